@@ -21,6 +21,7 @@ CircularBuffer::CircularBuffer()
     size = 0;
     mask = 0;
     sampleRate = 44100;
+    maxBlockSize = 0;
     // buffer = nullptr;
 }
 
@@ -36,7 +37,11 @@ void CircularBuffer::prepare(const juce::dsp::ProcessSpec& spec)
     jassert(spec.numChannels > 0);
 
     sampleRate = spec.sampleRate;
+    maxBlockSize = static_cast<int>(spec.maximumBlockSize);
 
+    // 3 extra samples for the Hermite taps around the block (xm1, x1, x2)
+    history.setSize(1, maxBlockSize + 3);
+    history.clear();
 }
 
 
@@ -50,12 +55,17 @@ void CircularBuffer::initBuffer(int numSamples)
     jassert(numSamples >= 0);
     jassert((numSamples & (numSamples - 1)) == 0); // check if power of two
 
+    generation.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
     size = numSamples;
     mask = size - 1;
 
     buffer.setSize(1, size);
     buffer.clear();
 
+    generation.fetch_add(1, std::memory_order_release);
+
     /* Version using pointer and malloc, for reference */
     // buffer = (float*)malloc(size * sizeof(float));
     
@@ -80,7 +90,9 @@ void CircularBuffer::initBuffer(int numSamples)
 
 
 void CircularBuffer::writeBuffer(float value) {
+    claimSequence(1);
     buffer.setSample(0, ++writePointer & mask, value); 
+    commitSequence();
 }
 
 
@@ -193,3 +205,262 @@ float CircularBuffer::readBufferHermite(float delay) {
 
     return ((c3 * readPointer_fractional + c2) * readPointer_fractional + c1) * readPointer_fractional + c0;
 }
+
+
+
+/**
+========================================== Block processing =============================================
+* When the delay is longer than the block, every sample read during the block was written before the
+* block started: the feedback recursion does not reach inside the block, so read and write can be done
+* as whole-block vector operations instead of sample by sample.
+* With a constant delay the Hermite fractional part is constant too, and the interpolation reduces
+* to a 4-tap FIR over a contiguous region of the buffer.
+=========================================================================================================
+*/
+
+/**
+* @brief checks whether a block of numSamples can be read with readBlockHermite()
+* @param float delay
+*   delay in samples, must cover the block plus the Hermite look-ahead
+* @param int numSamples
+*/
+bool CircularBuffer::canProcessBlock(float delay, int numSamples) const
+{
+    return numSamples <= maxBlockSize
+        && delay >= static_cast<float>(numSamples + 2)
+        && delay < static_cast<float>(size) - static_cast<float>(numSamples + 2);
+}
+
+/**
+* @brief copies numSamples from the buffer into dest, starting at index start (wraps around)
+*/
+void CircularBuffer::copyFromBuffer(float* dest, uint32_t start, int numSamples) const
+{
+    start &= mask;
+    int firstPart = juce::jmin(numSamples, static_cast<int>(size - start));
+
+    juce::FloatVectorOperations::copy(dest, buffer.getReadPointer(0, start), firstPart);
+    juce::FloatVectorOperations::copy(dest + firstPart, buffer.getReadPointer(0), numSamples - firstPart);
+}
+
+/**
+* @brief reads a block with Hermite interpolation and a constant delay
+* dest[n] is the value readBufferHermite(delay) would return after n more calls to writeBuffer()
+* @param float* dest
+* @param float delay
+*   see canProcessBlock()
+* @param int numSamples
+*/
+void CircularBuffer::readBlockHermite(float* dest, float delay, int numSamples)
+{
+    jassert(canProcessBlock(delay, numSamples));
+
+    // split delay without going through (writePointer - delay) in float, so that precision
+    // does not depend on how long the write pointer has been running
+    GET_INTEGRAL_FRACTIONAL(delay);
+
+    uint32_t readPointer = static_cast<uint32_t>(writePointer - delay_integral);
+    float mu = 0.0f;
+
+    if (delay_fractional > 0.0f)
+    {
+        --readPointer;
+        mu = 1.0f - delay_fractional;
+    }
+
+    // Hermite coefficients expanded as weights of xm1, x0, x1, x2 (see readBufferHermite)
+    float mu2 = mu * mu;
+    float mu3 = mu2 * mu;
+    float wm1 = -0.5f * mu + mu2 - 0.5f * mu3;
+    float w0 = 1.0f - 2.5f * mu2 + 1.5f * mu3;
+    float w1 = 0.5f * mu + 2.0f * mu2 - 1.5f * mu3;
+    float w2 = -0.5f * mu2 + 0.5f * mu3;
+
+    float* x = history.getWritePointer(0);
+    copyFromBuffer(x, readPointer - 1, numSamples + 3);
+
+    juce::FloatVectorOperations::copyWithMultiply(dest, x, wm1, numSamples);
+    juce::FloatVectorOperations::addWithMultiply(dest, x + 1, w0, numSamples);
+    juce::FloatVectorOperations::addWithMultiply(dest, x + 2, w1, numSamples);
+    juce::FloatVectorOperations::addWithMultiply(dest, x + 3, w2, numSamples);
+}
+
+/**
+* @brief writes a block into the buffer, same as numSamples calls to writeBuffer()
+* @param const float* source
+* @param int numSamples
+*/
+void CircularBuffer::writeBlock(const float* source, int numSamples)
+{
+    jassert(numSamples <= static_cast<int>(size));
+
+    claimSequence(numSamples);
+
+    uint32_t start = (writePointer + 1) & mask;
+    int firstPart = juce::jmin(numSamples, static_cast<int>(size - start));
+
+    juce::FloatVectorOperations::copy(buffer.getWritePointer(0, start), source, firstPart);
+    juce::FloatVectorOperations::copy(buffer.getWritePointer(0), source + firstPart, numSamples - firstPart);
+
+    writePointer += numSamples;
+    commitSequence();
+}
+
+
+/**
+* @brief copies the last numSamples written into dest, oldest first
+* @param float* dest
+* @param int numSamples
+*/
+void CircularBuffer::readLastWritten(float* dest, int numSamples) const
+{
+    jassert(numSamples <= static_cast<int>(size));
+
+    copyFromBuffer(dest, static_cast<uint32_t>(writePointer + 1 - numSamples), numSamples);
+}
+
+
+/**
+========================================== Multiple readers =============================================
+* Single writer, multiple readers, seqlock style. Sample number s lives at index (s & mask).
+* Before overwriting, the writer publishes claimedSequence (last sample about to be written) followed
+* by a release fence; after writing it publishes writeSequence (last sample written).
+* A reader owns its cursor, reads spans directly from the buffer, then after an acquire fence checks
+* claimedSequence: if the writer has claimed the slots of the span in the meantime, the span is dropped.
+* No locks, the audio thread never waits on a reader.
+* Span data is read as plain floats while the writer may be storing them: torn values are detected,
+* not prevented, which is the price of handing out zero-copy spans.
+=========================================================================================================
+*/
+
+/**
+* @brief announces that the next numSamples slots are about to be overwritten
+*/
+void CircularBuffer::claimSequence(int numSamples)
+{
+    claimedSequence.store(static_cast<uint32_t>(writePointer + numSamples), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+/**
+* @brief publishes the samples written since the last claim
+*/
+void CircularBuffer::commitSequence()
+{
+    writeSequence.store(static_cast<uint32_t>(writePointer), std::memory_order_release);
+}
+
+/**
+* @brief creates a reader starting at the current write position
+* @param const CircularBuffer& owner
+*/
+CircularBuffer::Reader::Reader(const CircularBuffer& owner) : circBuff(owner)
+{
+    resync();
+}
+
+/**
+* @brief moves the cursor to the newest published sample
+*/
+void CircularBuffer::Reader::resync()
+{
+    generation = circBuff.generation.load(std::memory_order_acquire);
+    readSequence = circBuff.writeSequence.load(std::memory_order_acquire);
+}
+
+/**
+* @brief true if the writer has claimed the slot of the next sample to read
+*/
+bool CircularBuffer::Reader::isLapped(uint32_t claimed) const
+{
+    return claimed - readSequence > circBuff.size;
+}
+
+/**
+* @brief number of samples getNextSpan() can still return, oldest valid sample included
+*/
+int CircularBuffer::Reader::getNumAvailable() const
+{
+    uint32_t currentGeneration = circBuff.generation.load(std::memory_order_acquire);
+
+    if (currentGeneration != generation)
+        return 0;
+
+    uint32_t claimed = circBuff.claimedSequence.load(std::memory_order_acquire);
+    uint32_t written = circBuff.writeSequence.load(std::memory_order_acquire);
+    uint32_t start = isLapped(claimed) ? claimed - circBuff.size : readSequence;
+
+    return static_cast<int>(written - start);
+}
+
+/**
+* @brief returns the next contiguous span of unread samples, without copying
+* The span stops at the end of the buffer, call again to get the part after the wrap.
+* Data must be consumed before finishRead(), which tells if it was still valid.
+* If the writer lapped the reader, the cursor moves to the oldest sample still in the buffer.
+* @param int maxSamples
+*/
+CircularBuffer::Span CircularBuffer::Reader::getNextSpan(int maxSamples)
+{
+    Span span;
+
+    uint32_t currentGeneration = circBuff.generation.load(std::memory_order_acquire);
+
+    if (currentGeneration & 1)
+        return span;   // initBuffer() running
+
+    if (currentGeneration != generation)
+    {
+        // buffer was cleared, older samples are gone
+        ++numOverruns;
+        resync();
+    }
+
+    uint32_t claimed = circBuff.claimedSequence.load(std::memory_order_acquire);
+    uint32_t written = circBuff.writeSequence.load(std::memory_order_acquire);
+
+    if (isLapped(claimed))
+    {
+        ++numOverruns;
+        readSequence = claimed - circBuff.size;
+    }
+
+    span.start = readSequence;
+
+    uint32_t first = (readSequence + 1) & circBuff.mask;
+    uint32_t available = written - readSequence;
+    available = juce::jmin(available, circBuff.size - first);
+    span.numSamples = juce::jmin(static_cast<int>(available), maxSamples);
+
+    if (span.numSamples > 0)
+        span.data = circBuff.buffer.getReadPointer(0, first);
+
+    return span;
+}
+
+/**
+* @brief advances the cursor past a span returned by getNextSpan()
+* @return false if the writer claimed part of the span while it was being read, or the buffer was
+*   cleared; the span should then be discarded and the next getNextSpan() call resyncs the reader
+*/
+bool CircularBuffer::Reader::finishRead(const Span& span)
+{
+    jassert(span.start == readSequence);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t claimed = circBuff.claimedSequence.load(std::memory_order_relaxed);
+    uint32_t currentGeneration = circBuff.generation.load(std::memory_order_relaxed);
+
+    if (currentGeneration != generation)
+        return false;
+
+    if (claimed - span.start > circBuff.size)
+    {
+        ++numOverruns;
+        readSequence = claimed - circBuff.size;
+        return false;
+    }
+
+    readSequence = span.start + static_cast<uint32_t>(span.numSamples);
+    return true;
+}
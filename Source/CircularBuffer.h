@@ -34,6 +34,50 @@ class CircularBuffer
        float readBufferLinear(float delay);
        float readBufferCubic(float delay);
        float readBufferHermite(float delay);
+
+       bool canProcessBlock(float delay, int numSamples) const;
+       void readBlockHermite(float* dest, float delay, int numSamples);
+       void writeBlock(const float* source, int numSamples);
+       void readLastWritten(float* dest, int numSamples) const;
+
+       /**
+       * Contiguous run of samples inside the buffer, handed out by Reader without copying.
+       * start is the sequence number of the sample just before data[0].
+       */
+       struct Span
+       {
+           const float* data{ nullptr };
+           int numSamples{ 0 };
+           uint32_t start{ 0 };
+       };
+
+       /**
+       * Independent read cursor for a non-realtime consumer (analyzer, meter, recorder...).
+       * One writer (the audio thread), any number of readers, no locks: each reader checks
+       * the claimed write sequence after reading and drops the span if it was overwritten.
+       * initBuffer() (prepareToPlay) bumps a generation counter and readers resync on it.
+       * The buffer must keep the same size while readers exist, a new size reallocates it.
+       */
+       class Reader
+       {
+          public:
+              explicit Reader(const CircularBuffer& owner);
+
+              int getNumAvailable() const;
+              Span getNextSpan(int maxSamples);
+              bool finishRead(const Span& span);
+              void resync();
+
+              uint32_t getNumOverruns() const { return numOverruns; }
+
+          private:
+              bool isLapped(uint32_t claimed) const;
+
+              const CircularBuffer& circBuff;
+              uint32_t readSequence{ 0 };
+              uint32_t generation{ 0 };
+              uint32_t numOverruns{ 0 };
+       };
        
    
    private: 
@@ -41,11 +85,22 @@ class CircularBuffer
        // float *buffer;
 
        juce::AudioBuffer<float> buffer;
+       juce::AudioBuffer<float> history;   // linear copy of the samples read by a block (maxBlockSize + 3)
+
+       void copyFromBuffer(float* dest, uint32_t start, int numSamples) const;
 
        uint32_t size;
        uint32_t mask;
 
        int sampleRate;
+       int maxBlockSize{ 0 };
        int writePointer{ 0 };
+
+       void claimSequence(int numSamples);
+       void commitSequence();
+
+       std::atomic<uint32_t> claimedSequence{ 0 };   // last sample being overwritten
+       std::atomic<uint32_t> writeSequence{ 0 };     // writePointer as published to readers
+       std::atomic<uint32_t> generation{ 0 };        // odd while initBuffer() is running
        
 };
\ No newline at end of file
@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+
+    Convolver.cpp
+
+    Uniformly partitioned overlap-save convolution.
+    Ref. Wefers, "Partitioned convolution algorithms for real-time auralization", 2015
+
+    Block k of the output is the second half of
+        IFFT( sum_p X[k - p] * H[p] )
+    where X[k] is the FFT of the input blocks k-1 and k, and H[p] the FFT of the p-th
+    partition of the impulse response, zero-padded to twice the partition size.
+    The sum over p >= 1 only depends on complete blocks and is computed once per block
+    (accumulator). X[k] * H[0] is recomputed on each call with the part of block k received
+    so far, so the output has no latency whatever the host block size.
+
+  ==============================================================================
+*/
+
+#include "Convolver.h"
+
+Convolver::Convolver()
+{
+}
+
+
+Convolver::~Convolver()
+{
+}
+
+/**
+* @brief allocates everything, nothing is allocated afterwards
+* @param const juce::dsp::ProcessSpec& spec
+* @param int maxImpulseLength
+*   longest impulse response (in samples) that loadImpulseResponse() will accept
+*/
+void Convolver::prepare(const juce::dsp::ProcessSpec& spec, int maxImpulseLength)
+{
+    const juce::ScopedLock lock(loadLock);
+
+    jassert(spec.maximumBlockSize > 0);
+    jassert(maxImpulseLength > 0);
+
+    blockSize = juce::nextPowerOfTwo(static_cast<int>(spec.maximumBlockSize));
+    fftSize = 2 * blockSize;
+    spectrumSize = fftSize + 2;
+
+    int order = 0;
+    while ((1 << order) < fftSize)
+        ++order;
+
+    fft = std::make_unique<juce::dsp::FFT>(order);
+    loadFft = std::make_unique<juce::dsp::FFT>(order);
+
+    maxPartitions = juce::jmax(1, (maxImpulseLength + blockSize - 1) / blockSize);
+
+    // power of 2 number of slots, same indexing as CircularBuffer
+    int numSlots = juce::nextPowerOfTwo(maxPartitions);
+    fdlMask = numSlots - 1;
+
+    fdl.setSize(numSlots, spectrumSize);
+    irSpectra.setSize(2 * maxPartitions, spectrumSize);
+    irSpectra.clear();
+    accumulator.setSize(1, spectrumSize);
+    frame.setSize(1, 2 * fftSize);
+    loadFrame.setSize(1, 2 * fftSize);
+
+    inputHistory.prepare(spec);
+
+    activeBank = -1;
+    numActivePartitions = 0;
+    lastPublishedBank = 1;
+    bankPartitions[0] = bankPartitions[1] = 0;
+    pendingBank.store(-1);
+
+    reset();
+
+    // keep the impulse response loaded before a buffer size / sample rate change
+    if (impulseCopy.getNumSamples() > 0)
+        publishImpulseResponse();
+}
+
+/**
+* @brief clears input history and pending output
+*/
+void Convolver::reset()
+{
+    inputHistory.initBuffer(fftSize);
+    fdl.clear();
+    accumulator.clear();
+
+    fdlPosition = 0;
+    blockPosition = 0;
+}
+
+
+/**
+========================================== Impulse response =============================================
+* Two banks of partition spectra: the audio thread convolves with one, the loading thread fills the
+* other and publishes it through pendingBank. The audio thread picks it up at the next block boundary.
+* If a load comes before the previous one was picked up, the loading thread takes its bank back.
+* Loading and prepare() are serialized by loadLock, which the audio thread never takes.
+=========================================================================================================
+*/
+
+/**
+* @brief keeps a copy of an impulse response and hands its partition spectra to the audio thread
+* If called before prepare(), the impulse response is only stored and prepare() partitions it.
+* @param const float* impulse
+* @param int numSamples
+*   impulses longer than maxImpulseLength (see prepare) are truncated
+*/
+void Convolver::loadImpulseResponse(const float* impulse, int numSamples)
+{
+    const juce::ScopedLock lock(loadLock);
+
+    impulseCopy.setSize(1, numSamples);
+    impulseCopy.copyFrom(0, 0, impulse, numSamples);
+
+    if (fft != nullptr)
+        publishImpulseResponse();
+}
+
+/**
+* @brief computes the partition spectra of impulseCopy into the idle bank and publishes it
+* Called with loadLock held.
+*/
+void Convolver::publishImpulseResponse()
+{
+    int previous = pendingBank.exchange(-1);
+    int bank = previous >= 0 ? previous : 1 - lastPublishedBank;
+
+    const float* impulse = impulseCopy.getReadPointer(0);
+    int numSamples = impulseCopy.getNumSamples();
+
+    int numPartitions = juce::jlimit(1, maxPartitions, (numSamples + blockSize - 1) / blockSize);
+    float* data = loadFrame.getWritePointer(0);
+
+    for (int p = 0; p < numPartitions; p++)
+    {
+        int start = p * blockSize;
+        int length = juce::jlimit(0, blockSize, numSamples - start);
+
+        juce::FloatVectorOperations::clear(data, 2 * fftSize);
+        juce::FloatVectorOperations::copy(data, impulse + start, length);
+
+        loadFft->performRealOnlyForwardTransform(data, true);
+        juce::FloatVectorOperations::copy(irSpectra.getWritePointer(bank * maxPartitions + p), data, spectrumSize);
+    }
+
+    bankPartitions[bank] = numPartitions;
+    lastPublishedBank = bank;
+    pendingBank.store(bank, std::memory_order_release);
+}
+
+/**
+* @brief switches to the last published impulse response, if any. Audio thread, block boundary only
+*/
+void Convolver::updateImpulseResponse()
+{
+    int bank = pendingBank.exchange(-1, std::memory_order_acq_rel);
+
+    if (bank < 0)
+        return;
+
+    // history is not kept up to date while bypassed
+    if (activeBank < 0)
+        reset();
+
+    activeBank = bank;
+    numActivePartitions = bankPartitions[bank];
+}
+
+
+/**
+========================================== Processing ===================================================
+*/
+
+/**
+* @brief convolves samples in place with the current impulse response
+* Leaves samples untouched as long as no impulse response has been loaded.
+* @param float* samples
+* @param int numSamples
+*   any block size, not limited to the prepared one
+*/
+void Convolver::process(float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        if (blockPosition == 0)
+        {
+            updateImpulseResponse();
+
+            if (activeBank >= 0)
+                computeAccumulator();
+        }
+
+        if (activeBank < 0)
+            return;
+
+        int n = juce::jmin(numSamples, blockSize - blockPosition);
+        processPartialBlock(samples, n);
+
+        samples += n;
+        numSamples -= n;
+    }
+}
+
+/**
+* @brief sum over p >= 1 of X[k - p] * H[p], for the block k about to start
+*/
+void Convolver::computeAccumulator()
+{
+    float* dest = accumulator.getWritePointer(0);
+    juce::FloatVectorOperations::clear(dest, spectrumSize);
+
+    for (int p = 1; p < numActivePartitions; p++)
+    {
+        const float* input = fdl.getReadPointer((fdlPosition - p) & fdlMask);
+        const float* partition = irSpectra.getReadPointer(activeBank * maxPartitions + p);
+
+        multiplyAccumulate(dest, input, partition);
+    }
+}
+
+/**
+* @brief processes numSamples within the current block
+* @param float* samples
+* @param int numSamples
+*   must not go past the end of the block
+*/
+void Convolver::processPartialBlock(float* samples, int numSamples)
+{
+    jassert(blockPosition + numSamples <= blockSize);
+
+    inputHistory.writeBlock(samples, numSamples);
+    blockPosition += numSamples;
+
+    // previous block + what we have of the current one, zero-padded
+    float* data = frame.getWritePointer(0);
+    int numValid = blockSize + blockPosition;
+
+    inputHistory.readLastWritten(data, numValid);
+    juce::FloatVectorOperations::clear(data + numValid, 2 * fftSize - numValid);
+
+    fft->performRealOnlyForwardTransform(data, true);
+
+    float* current = fdl.getWritePointer(fdlPosition & fdlMask);
+    juce::FloatVectorOperations::copy(current, data, spectrumSize);
+
+    juce::FloatVectorOperations::copy(data, accumulator.getReadPointer(0), spectrumSize);
+    multiplyAccumulate(data, current, irSpectra.getReadPointer(activeBank * maxPartitions));
+
+    // bins above fftSize/2 are rebuilt from their conjugates by the inverse transform
+    fft->performRealOnlyInverseTransform(data);
+
+    juce::FloatVectorOperations::copy(samples, data + numValid - numSamples, numSamples);
+
+    if (blockPosition == blockSize)
+    {
+        blockPosition = 0;
+        ++fdlPosition;
+    }
+}
+
+/**
+* @brief dest += a * b, complex multiply over bins 0..fftSize/2 (interleaved re/im)
+*/
+void Convolver::multiplyAccumulate(float* dest, const float* a, const float* b) const
+{
+    for (int i = 0; i < spectrumSize; i += 2)
+    {
+        float re = a[i] * b[i] - a[i + 1] * b[i + 1];
+        float im = a[i] * b[i + 1] + a[i + 1] * b[i];
+
+        dest[i] += re;
+        dest[i + 1] += im;
+    }
+}
\ No newline at end of file
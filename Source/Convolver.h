@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    Convolver.h
+
+    Uniformly partitioned overlap-save convolution, for long impulse responses
+    (cabinet sims, room tails).
+    Partition size = FFT size / 2 = host block size rounded up to a power of 2.
+    Input history in a CircularBuffer, partition spectra in a frequency-domain delay line
+    indexed with the same bitwise AND. No latency: the current partial block is recomputed
+    on each call.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CircularBuffer.h"
+
+class Convolver
+{
+   public:
+       Convolver();
+       ~Convolver();
+       void prepare(const juce::dsp::ProcessSpec& spec, int maxImpulseLength);
+       void reset();
+
+       void loadImpulseResponse(const float* impulse, int numSamples);
+
+       void process(float* samples, int numSamples);
+
+
+   private:
+
+       void processPartialBlock(float* samples, int numSamples);
+       void publishImpulseResponse();
+       void updateImpulseResponse();
+       void computeAccumulator();
+       void multiplyAccumulate(float* dest, const float* a, const float* b) const;
+
+       std::unique_ptr<juce::dsp::FFT> fft;       // audio thread
+       std::unique_ptr<juce::dsp::FFT> loadFft;   // loading thread
+
+       CircularBuffer inputHistory;
+
+       juce::AudioBuffer<float> fdl;           // frequency-domain delay line, one input spectrum per channel
+       juce::AudioBuffer<float> irSpectra;     // 2 banks of maxPartitions spectra: one in use, one for loading
+       juce::AudioBuffer<float> accumulator;   // contribution of the previous blocks to the current one
+       juce::AudioBuffer<float> frame;         // FFT work buffer (2 * fftSize), audio thread
+       juce::AudioBuffer<float> loadFrame;     // FFT work buffer (2 * fftSize), loading thread
+
+       int blockSize{ 0 };
+       int fftSize{ 0 };
+       int spectrumSize{ 0 };   // bins 0..fftSize/2, interleaved complex
+       int maxPartitions{ 0 };
+
+       uint32_t fdlMask{ 0 };
+       uint32_t fdlPosition{ 0 };
+       int blockPosition{ 0 };
+
+       // audio thread
+       int activeBank{ -1 };
+       int numActivePartitions{ 0 };
+
+       // loading thread, under loadLock
+       juce::CriticalSection loadLock;          // never taken by the audio thread
+       juce::AudioBuffer<float> impulseCopy;    // last loaded impulse response, re-partitioned by prepare()
+       int lastPublishedBank{ 1 };
+       int bankPartitions[2]{ 0, 0 };
+
+       std::atomic<int> pendingBank{ -1 };
+
+       JUCE_DECLARE_NON_COPYABLE(Convolver)
+};
\ No newline at end of file
@@ -101,6 +101,11 @@ void Test_circ_bufferAudioProcessor::prepareToPlay (double sampleRate, int sampl
     circBuff.prepare(spec);
     circBuff.initBuffer(262144); // around 5.5 seconds in 48kHz
 
+    blockBuffer.setSize(2, samplesPerBlock);
+    blockBuffer.clear();
+
+    convolver.prepare(spec, 262144);
+
     //delayBuffer.setSize(getTotalNumOutputChannels(), circBuff.delaySize);
     //delayBuffer.clear();
 
@@ -157,30 +162,84 @@ void Test_circ_bufferAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
 
     
     smoothDelay.setTargetValue(delayTime);
+
+    // Delay at least one block long and not ramping: nothing read in this block is written in this block,
+    // so the feedback loop can run as whole-block vector operations.
+    bool vectorized = false;
+
+    if (!smoothDelay.isSmoothing())
+    {
+        float delayTimeSmps = smoothDelay.getCurrentValue() * getSampleRate();
+
+        if (circBuff.canProcessBlock(delayTimeSmps, buffer.getNumSamples()))
+        {
+            processBlockVectorized(buffer, delayTimeSmps);
+            vectorized = true;
+        }
+    }
     
-    for (int sample = 0; sample < buffer.getNumSamples(); sample++)
+    if (!vectorized)
     {
-        float inputSample = (*(leftInSamples + sample) + *(rightInSamples + sample)) * 0.5; // mixdown to mono
+        for (int sample = 0; sample < buffer.getNumSamples(); sample++)
+        {
+            float inputSample = (*(leftInSamples + sample) + *(rightInSamples + sample)) * 0.5; // mixdown to mono
 
-        auto currentDelayTime = smoothDelay.getNextValue();
+            auto currentDelayTime = smoothDelay.getNextValue();
 
-        float delayTimeSmps = currentDelayTime * getSampleRate();
+            float delayTimeSmps = currentDelayTime * getSampleRate();
        
-        /***************************** read from delay line *******************************/
-        // Without interpolation.. delay time truncated to integer samples
-        // float delaySample = circBuff.readBuffer(delayTimeSmps);
+            /***************************** read from delay line *******************************/
+            // Without interpolation.. delay time truncated to integer samples
+            // float delaySample = circBuff.readBuffer(delayTimeSmps);
 
-        // With Hermite interpolation
-        float delayedSample = circBuff.readBufferHermite(delayTimeSmps);
+            // With Hermite interpolation
+            float delayedSample = circBuff.readBufferHermite(delayTimeSmps);
 
-        /***************************** dry/wet mix and output *****************************/
-        float outputSample = delayedSample * mix + inputSample * (1 - mix);
-        *(leftOutSamples + sample)  = outputSample;
-        *(rightOutSamples + sample) = outputSample;
+            /***************************** dry/wet mix and output *****************************/
+            float outputSample = delayedSample * mix + inputSample * (1 - mix);
+            *(leftOutSamples + sample)  = outputSample;
+            *(rightOutSamples + sample) = outputSample;
          
-        /**************************** write into delay line *******************************/
-        circBuff.writeBuffer(inputSample + feedback*delayedSample);         
-    }      
+            /**************************** write into delay line *******************************/
+            circBuff.writeBuffer(inputSample + feedback*delayedSample);         
+        }      
+    }
+
+    /********************************** convolution ***********************************/
+    // does nothing until an impulse response is loaded
+    convolver.process(leftOutSamples, buffer.getNumSamples());
+    juce::FloatVectorOperations::copy(rightOutSamples, leftOutSamples, buffer.getNumSamples());
+}
+
+/**
+* @brief same as the sample loop in processBlock(), with a constant delay of at least one block
+* @param float delayTimeSmps
+*   checked with CircularBuffer::canProcessBlock() beforehand
+*/
+void Test_circ_bufferAudioProcessor::processBlockVectorized(juce::AudioBuffer<float>& buffer, float delayTimeSmps)
+{
+    int numSamples = buffer.getNumSamples();
+
+    auto leftOutSamples = buffer.getWritePointer(0);
+    auto rightOutSamples = buffer.getWritePointer(1);
+    auto inputSamples = blockBuffer.getWritePointer(0);
+    auto delayedSamples = blockBuffer.getWritePointer(1);
+
+    // mixdown to mono
+    juce::FloatVectorOperations::add(inputSamples, buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
+    juce::FloatVectorOperations::multiply(inputSamples, 0.5f, numSamples);
+
+    /***************************** read from delay line *******************************/
+    circBuff.readBlockHermite(delayedSamples, delayTimeSmps, numSamples);
+
+    /***************************** dry/wet mix and output *****************************/
+    juce::FloatVectorOperations::copyWithMultiply(leftOutSamples, inputSamples, 1 - mix, numSamples);
+    juce::FloatVectorOperations::addWithMultiply(leftOutSamples, delayedSamples, mix, numSamples);
+    juce::FloatVectorOperations::copy(rightOutSamples, leftOutSamples, numSamples);
+
+    /**************************** write into delay line *******************************/
+    juce::FloatVectorOperations::addWithMultiply(inputSamples, delayedSamples, feedback, numSamples);
+    circBuff.writeBlock(inputSamples, numSamples);
 }
 
 
@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "CircularBuffer.h"
+#include "Convolver.h"
 
 //==============================================================================
 /**
@@ -57,13 +58,21 @@ public:
 
     juce::AudioProcessorValueTreeState apvts;
 
+    // for analysis threads, see CircularBuffer::Reader
+    const CircularBuffer& getCircularBuffer() const { return circBuff; }
+
+    // impulse responses are loaded from a non-realtime thread, see Convolver::loadImpulseResponse
+    Convolver& getConvolver() { return convolver; }
+
 private:
 
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
     void parameterChanged(const juce::String& parameterID, float newValue);
+    void processBlockVectorized(juce::AudioBuffer<float>& buffer, float delayTimeSmps);
     juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> smoothDelay;
 
     CircularBuffer circBuff;
+    Convolver convolver;
 
     float delayTime{ 0 };
     float currentDelayTime{ 0 };
@@ -71,6 +80,7 @@ private:
     float mix{ 0 };
 
     // juce::AudioBuffer<float> delayBuffer;
+    juce::AudioBuffer<float> blockBuffer;   // channel 0: mono input, channel 1: delayed signal
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Test_circ_bufferAudioProcessor)